@@ -1,24 +1,519 @@
 /*
 	Author: Kai Li
 	Date: Jan 3, 2017
-	Description: This simple C++ program is used to 
-	read words (Delimit by white space) from user 
-	input and output to console the count of words 
+	Description: This simple C++ program is used to
+	read words (Delimit by white space) from user
+	input and output to console the count of words
 	that start with an English vowel.
+
+	The counting is done by a small word-statistics
+	engine: each statistic is a class with an add(word)
+	and a print(os) method, and WordStats<...> fuses any
+	number of them into a single pass over the input.
+	Run with --all to also print the total word count,
+	the histogram of initial letters and the histogram
+	of word lengths (still in one pass).
+	The engine uses std::index_sequence, so this file
+	requires C++14 (e.g., g++ -std=c++14).
+
+	For unbounded input (e.g., a growing log piped in
+	via tail -f) use one of --every-lines N,
+	--every-bytes N or --every-secs N to print the
+	running count every N lines, bytes or seconds
+	(seconds from 0.001, the resolution of poll()).
+	Adding --window K (at most 65536) also prints the
+	count over the last K intervals. Streaming keeps
+	only a few counters in total and a fixed ring of K
+	interval counts, so memory stays constant no matter
+	how long the input or its words are.
 */
+#include <poll.h>
+#include <unistd.h>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// ---------------------------------------------------------------
+// Predicates (decide whether a word is counted)
+// ---------------------------------------------------------------
+
+/**
+ * Predicate that is true for words starting with an English vowel,
+ * i.e., one of "AEIOUaeiou" characters.
+ */
+struct StartsWithVowel {
+    bool operator()(const std::string& word) const {
+        return (*this)(word[0]);
+    }
+    bool operator()(char first) const {
+        switch (first) {
+        case 'A': case 'E': case 'I': case 'O': case 'U':
+        case 'a': case 'e': case 'i': case 'o': case 'u':
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+/**
+ * Predicate that is true for every word.
+ */
+struct AnyWord {
+    bool operator()(const std::string&) const { return true; }
+};
+
+// ---------------------------------------------------------------
+// Keys (map a word to a histogram bin)
+// ---------------------------------------------------------------
+
+/**
+ * Histogram key that bins words by their first character.
+ */
+struct InitialLetter {
+    static constexpr std::size_t Bins = 256;
+    std::size_t operator()(const std::string& word) const {
+        return static_cast<unsigned char>(word[0]);
+    }
+    // Control bytes and non-ASCII bytes (e.g., UTF-8 lead bytes) are
+    // printed as a \xNN escape so they do not reach the terminal raw.
+    static void label(std::ostream& os, std::size_t bin) {
+        if (bin > ' ' && bin < 0x7f) {
+            os << static_cast<char>(bin);
+        } else {
+            const char* Hex = "0123456789abcdef";
+            os << "\\x" << Hex[bin >> 4] << Hex[bin & 0xf];
+        }
+    }
+};
+
+/**
+ * Histogram key that bins words by their length. Words of
+ * MaxLen or more characters share the last bin.
+ */
+struct WordLength {
+    static constexpr std::size_t MaxLen = 32;
+    static constexpr std::size_t Bins = MaxLen + 1;
+    std::size_t operator()(const std::string& word) const {
+        return (word.size() < MaxLen) ? word.size() : MaxLen;
+    }
+    static void label(std::ostream& os, std::size_t bin) {
+        os << bin << ((bin == MaxLen) ? "+" : "");
+    }
+};
+
+// ---------------------------------------------------------------
+// Accumulators (the statistics themselves)
+// ---------------------------------------------------------------
+
+/**
+ * Counts the words for which Pred is true.
+ */
+template<typename Pred>
+class CountIf {
+public:
+    explicit CountIf(const char* name = "count") : name(name) {}
+
+    void add(const std::string& word) {
+        count += pred(word) ? 1 : 0;
+    }
+
+    std::size_t value() const { return count; }
+
+    void print(std::ostream& os) const {
+        os << name << ": " << count << '\n';
+    }
+
+private:
+    const char* name;
+    Pred pred;
+    std::size_t count = 0;
+};
+
+/**
+ * Counts words per bin, where the bin of a word is given by Key.
+ * Only non-empty bins are printed.
+ */
+template<typename Key>
+class Histogram {
+public:
+    explicit Histogram(const char* name = "histogram") : name(name) {
+        bins.fill(0);
+    }
+
+    void add(const std::string& word) {
+        bins[key(word)]++;
+    }
+
+    void print(std::ostream& os) const {
+        os << name << ":\n";
+        for (std::size_t bin = 0; bin < Key::Bins; bin++) {
+            if (bins[bin] != 0) {
+                os << "  ";
+                Key::label(os, bin);
+                os << ": " << bins[bin] << '\n';
+            }
+        }
+    }
+
+private:
+    const char* name;
+    Key key;
+    std::array<std::size_t, Key::Bins> bins;
+};
+
+// The built-in statistics
+using VowelCount       = CountIf<StartsWithVowel>;
+using TotalCount       = CountIf<AnyWord>;
+using InitialHistogram = Histogram<InitialLetter>;
+using LengthHistogram  = Histogram<WordLength>;
 
-int main() {
-    const std::string Vowels = "AEIOUaeiou";    
-    int count = 0;
-    std::string word;
-    while (std::cin >> word) {
-        if (Vowels.find(word.at(0)) != std::string::npos) {
-            count++;
+// ---------------------------------------------------------------
+// The engine
+// ---------------------------------------------------------------
+
+/**
+ * Runs several statistics over the same words in a single pass.
+ * The list of statistics is fixed at compile time, so add() is
+ * expanded into a straight sequence of calls that the compiler
+ * can inline into the read loop.
+ */
+template<typename... Stats>
+class WordStats {
+public:
+    explicit WordStats(Stats... stats) : stats(std::move(stats)...) {}
+
+    /**
+     * Reads whitespace delimited words from is until end-of-file
+     * and feeds each one to every statistic.
+     */
+    void run(std::istream& is) {
+        std::string word;
+        while (is >> word) {
+            add(word);
         }
     }
-    std::cout << count << std::endl;
+
+    /**
+     * Feeds one (non-empty) word to every statistic.
+     */
+    void add(const std::string& word) {
+        addEach(word, std::index_sequence_for<Stats...>{});
+    }
+
+    /**
+     * Prints every statistic, in the order they were listed.
+     */
+    void print(std::ostream& os) const {
+        printEach(os, std::index_sequence_for<Stats...>{});
+    }
+
+    template<std::size_t I>
+    const typename std::tuple_element<I, std::tuple<Stats...>>::type&
+    get() const {
+        return std::get<I>(stats);
+    }
+
+private:
+    template<std::size_t... I>
+    void addEach(const std::string& word, std::index_sequence<I...>) {
+        using expand = int[];
+        (void) expand{0, (std::get<I>(stats).add(word), 0)...};
+    }
+
+    template<std::size_t... I>
+    void printEach(std::ostream& os, std::index_sequence<I...>) const {
+        using expand = int[];
+        (void) expand{0, (std::get<I>(stats).print(os), 0)...};
+    }
+
+    std::tuple<Stats...> stats;
+};
+
+/**
+ * Convenience method to build a WordStats engine from a list of
+ * statistics without spelling out their types.
+ */
+template<typename... Stats>
+WordStats<Stats...> makeWordStats(Stats... stats) {
+    return WordStats<Stats...>(std::move(stats)...);
+}
+
+// ---------------------------------------------------------------
+// Streaming mode
+// ---------------------------------------------------------------
+
+// The largest --window accepted, so the ring stays small
+const std::size_t MaxWindow = 65536;
+
+// The smallest --every-secs accepted, as poll() waits in whole ms
+const double MinSecs = 0.001;
+
+// The largest --every-secs accepted (about 11 days)
+const double MaxSecs = 1e6;
+
+/**
+ * When streaming, how often to print counts. Exactly one of lines,
+ * bytes or secs is non-zero. If window is non-zero the count over
+ * the last window intervals is printed as well.
+ */
+struct StreamOptions {
+    std::size_t lines = 0;
+    std::size_t bytes = 0;
+    double secs = 0;
+    std::size_t window = 0;
+};
+
+/**
+ * Keeps the running vowel-word count and the per-interval counts
+ * of the sliding window. The window is a fixed-size ring, so the
+ * memory used does not grow with the input.
+ */
+class StreamReporter {
+public:
+    StreamReporter(std::ostream& os, std::size_t window)
+        : os(os), ring(window, 0) {}
+
+    /**
+     * Prints the running count (and window count, if enabled) and
+     * starts a new interval.
+     */
+    void emit(std::size_t count) {
+        reported = true;
+        os << count;
+        if (!ring.empty()) {
+            const std::size_t delta = count - lastCount;
+            windowSum += delta - ring[pos];
+            ring[pos] = delta;
+            pos = (pos + 1) % ring.size();
+            os << ' ' << windowSum;
+        }
+        os << std::endl;
+        lastCount = count;
+    }
+
+    /**
+     * Adds n empty intervals to the window without printing them,
+     * e.g., for timed reports that were missed. Only the last
+     * ring.size() of them can matter, so at most that many are added.
+     */
+    void skip(std::size_t n) {
+        for (std::size_t i = 0; (i < n) && (i < ring.size()); i++) {
+            windowSum -= ring[pos];
+            ring[pos] = 0;
+            pos = (pos + 1) % ring.size();
+        }
+    }
+
+    /**
+     * Prints the final count at end-of-file, unless the last report
+     * already showed it (e.g., input ended on an interval boundary).
+     */
+    void finish(std::size_t count) {
+        if (!reported || count != lastCount) {
+            emit(count);
+        }
+    }
+
+private:
+    std::ostream& os;
+    std::vector<std::size_t> ring;
+    std::size_t pos = 0, windowSum = 0, lastCount = 0;
+    bool reported = false;
+};
+
+/**
+ * Reads raw blocks from fd until end-of-file and prints the running
+ * count of words starting with a vowel as configured in opts. A word
+ * is counted as soon as its first character is seen; after that only
+ * the fact that we are inside a word is remembered. So a word cut at
+ * the end of a block is carried over in constant space.
+ *
+ * @return 0 on success, 2 on a read error.
+ */
+int streamCount(int fd, std::ostream& os, const StreamOptions& opts) {
+    using Clock = std::chrono::steady_clock;
+    using Millis = std::chrono::milliseconds;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(opts.secs));
+    const StartsWithVowel isVowel;
+    StreamReporter reporter(os, opts.window);
+    std::size_t count = 0, lines = 0, bytes = 0;
+    bool inWord = false;  // true if the last byte was part of a word
+    auto deadline = Clock::now() + period;
+    char buf[64 * 1024];
+    while (true) {
+        if (opts.secs > 0) {
+            const auto now = Clock::now();
+            if (now >= deadline) {
+                reporter.emit(count);
+                deadline += period;
+                if (deadline <= now) {
+                    // Fell behind (e.g., slow output): skip missed reports
+                    // but still count them as (empty) window intervals
+                    const auto missed = (now - deadline) / period + 1;
+                    reporter.skip(static_cast<std::size_t>(missed));
+                    deadline += missed * period;
+                }
+            }
+            // Wait for input, but not past the next report time. The
+            // wait is rounded up so that we never wake up early.
+            const auto left = deadline - Clock::now();
+            auto wait = std::chrono::duration_cast<Millis>(left);
+            if (wait < left) {
+                wait += Millis(1);
+            }
+            pollfd pfd{fd, POLLIN, 0};
+            const int ready = poll(&pfd, 1, (wait.count() > 0) ?
+                                   static_cast<int>(wait.count()) : 0);
+            if (ready < 0 && errno != EINTR) {
+                std::cerr << "Error reading input.\n";
+                return 2;
+            }
+            if (ready <= 0) {
+                continue;  // Timed out or interrupted
+            }
+        }
+        const ssize_t len = read(fd, buf, sizeof(buf));
+        if (len == 0) {
+            break;
+        }
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error reading input.\n";
+            return 2;
+        }
+        for (ssize_t i = 0; i < len; i++) {
+            const char c = buf[i];
+            // Same whitespace set as operator>> in the "C" locale
+            if (c == ' ' || c == '\n' || c == '\t' || c == '\r' ||
+                c == '\v' || c == '\f') {
+                inWord = false;
+                if (c == '\n' && opts.lines > 0 && ++lines == opts.lines) {
+                    reporter.emit(count);
+                    lines = 0;
+                }
+            } else if (!inWord) {
+                inWord = true;
+                count += isVowel(c) ? 1 : 0;
+            }
+            if (opts.bytes > 0 && ++bytes == opts.bytes) {
+                reporter.emit(count);
+                bytes = 0;
+            }
+        }
+    }
+    reporter.finish(count);
+    return 0;
+}
+
+/**
+ * Convenience method to parse a whole number given as the value of a
+ * command-line option.
+ *
+ * @return true if str has only digits and is in the range 1..max.
+ */
+bool parseCount(const std::string& str, std::size_t max,
+                std::size_t& value) {
+    if (str.empty() ||
+        str.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    try {
+        const unsigned long long num = std::stoull(str);
+        if (num < 1 || num > max) {
+            return false;
+        }
+        value = static_cast<std::size_t>(num);
+        return true;
+    } catch (const std::out_of_range&) {
+        return false;
+    }
+}
+
+/**
+ * Convenience method to parse the number of seconds given as the
+ * value of --every-secs.
+ *
+ * @return true if str is a finite number in [MinSecs, MaxSecs].
+ */
+bool parseSecs(const std::string& str, double& value) {
+    try {
+        std::size_t used = 0;
+        const double num = std::stod(str, &used);
+        if (used != str.size() || !std::isfinite(num) ||
+            !(num >= MinSecs) || num > MaxSecs) {
+            return false;
+        }
+        value = num;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    bool all = false;
+    int intervals = 0;
+    StreamOptions opts;
+    bool ok = true;
+    for (int i = 1; (i < argc) && ok; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--all") {
+            all = true;
+        } else if (i + 1 >= argc) {
+            ok = false;
+        } else if (arg == "--every-lines") {
+            ok = parseCount(argv[++i], SIZE_MAX, opts.lines);
+            intervals++;
+        } else if (arg == "--every-bytes") {
+            ok = parseCount(argv[++i], SIZE_MAX, opts.bytes);
+            intervals++;
+        } else if (arg == "--every-secs") {
+            ok = parseSecs(argv[++i], opts.secs);
+            intervals++;
+        } else if (arg == "--window") {
+            ok = parseCount(argv[++i], MaxWindow, opts.window);
+        } else {
+            ok = false;
+        }
+    }
+    // Streaming prints only the vowel-word count, at one interval
+    if (!ok || intervals > 1 || (intervals == 1 && all) ||
+        (intervals == 0 && opts.window > 0)) {
+        std::cerr << "Usage: " << argv[0] << " [--all]\n"
+                  << "       " << argv[0] << " --every-lines N | "
+                  << "--every-bytes N | --every-secs N [--window K]\n"
+                  << "       (K at most " << MaxWindow << ", seconds from " << MinSecs
+                  << " to " << static_cast<long>(MaxSecs) << ")\n";
+        return 1;
+    }
+    if (intervals == 1) {
+        return streamCount(STDIN_FILENO, std::cout, opts);
+    }
+    if (all) {
+        auto engine = makeWordStats(TotalCount("words"),
+                                    VowelCount("vowel words"),
+                                    InitialHistogram("initial letters"),
+                                    LengthHistogram("word lengths"));
+        engine.run(std::cin);
+        engine.print(std::cout);
+    } else {
+        WordStats<VowelCount> engine{VowelCount()};
+        engine.run(std::cin);
+        std::cout << engine.get<0>().value() << std::endl;
+    }
     return 0;
 }
 